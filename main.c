@@ -1,5 +1,6 @@
 #include "raylib.h"
 #include "raymath.h"
+#include "rlgl.h"
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -39,16 +40,51 @@ typedef struct Clumpnugget
     } move_style;
 } Clumpnugget;
 
+typedef struct Input
+{
+    Vector2 mouse_position;
+    bool thrusters_on;
+    double sample_time;
+} Input;
+
 typedef struct Food
 {
     Vector2 position;
     Vector2 velocity;
     bool consumed;
+
+    // intrusive links into the food grid bucket at (cell_x, cell_y)
+    struct Food* prev_in_cell;
+    struct Food* next_in_cell;
+    int cell_x;
+    int cell_y;
 } Food;
 
+typedef struct FoodGridRange
+{
+    int min_x;
+    int min_y;
+    int max_x;
+    int max_y;
+} FoodGridRange;
+
+// fixed-capacity pool kept dense, dead particles are swapped with the last live one
+typedef struct Particles
+{
+    Vector2 position[4096];
+    Vector2 velocity[4096];
+    float life[4096];
+    float lifetime[4096];
+    Color color[4096];
+    int count;
+} Particles;
+
 Invader g_invader;
+Input g_input;
 Clumpnugget g_clumpnuggets[200];
 Food g_food[400];
+Food* g_food_grid[40][40];
+Particles g_particles;
 Camera2D g_camera;
 Font g_font;
 Sound g_pickup_sound, g_low_hp_sound;
@@ -105,6 +141,8 @@ const float g_hunger_timer_reset = 15.0f;
 const float g_next_round_timer_reset = 3.0f;
 const float g_dash_eligibility_period = 0.2f;
 const float g_crosshair_radius = 30.0f;
+const float g_particle_size = 6.0f;
+const float g_particle_drag = 3.0f;
 const int g_additional_clumpnuggets_per_round = 40;
 int g_attached_clumpnuggets = 0;
 int g_food_consumed = 0;
@@ -117,6 +155,7 @@ int g_difficulty = 1;
 int g_game_round = 0;
 int g_alive_clumpnuggets = 0;
 int g_menu_selection = 0;
+float g_sample_to_swap_time = 0.0f;
 const char* g_menu_items[] = {"Start", "How to play?", "Quit"};
 
 #ifdef NDEBUG
@@ -130,20 +169,30 @@ void RunGame();
 void CloseGame();
 void InitializeGameSpecifics();
 void Update(const float frame_time);
-void UpdateCamera2D(const float frame_time);
+void SampleInput();
 void UpdateInvader(const float frame_time);
 void UpdateClumpnuggets(const float frame_time);
 void UpdateFood(const float frame_time);
+void BuildFoodGrid();
+void InsertFoodIntoGrid(Food* food);
+void RemoveFoodFromGrid(Food* food);
+void RefreshFoodGridCell(Food* food);
+FoodGridRange GetFoodGridRange(const Rectangle area);
+Rectangle GetCircleBounds(const Vector2 center, const float radius);
 void UpdateInGameState(const float frame_time);
 void UpdateMenu();
 void UpdateHowToPlay();
 void UpdateGameWin(const float frame_time);
 void Render(const float frame_time);
+void LateLatchView();
 void RenderWorld(const float frame_time);
 void RenderBackground();
 void RenderInvader();
 void RenderClumpnuggets();
 void RenderFood();
+void EmitParticles(const Vector2 position, const int count, const float speed, const float lifetime, const Color color);
+void UpdateParticles(const float frame_time);
+void RenderParticles();
 void RenderUI();
 void RenderInGameUI();
 void RenderGameWinUI();
@@ -182,6 +231,8 @@ void InitializeGame()
     PlayMusicStream(g_ambient_music);
     SetMusicVolume(g_ambient_music, 0.5f);
 
+    g_camera.offset = (Vector2){g_screen_width / 2.0f, g_screen_height / 2.0f};
+    g_camera.zoom = 1.0f;
     g_game_state = Menu;
 }
 
@@ -192,6 +243,7 @@ void RunGame()
         const float frame_time = GetFrameTime();
         Update(frame_time);
         Render(frame_time);
+        g_sample_to_swap_time = g_debug_mode ? (float)(GetTime() - g_input.sample_time) : 0.0f;
     }
 }
 
@@ -233,6 +285,8 @@ void InitializeGameSpecifics()
         g_food[i].position = (Vector2){(float)GetRandomValue(-x, x), (float)GetRandomValue(-y, y)};
         g_food[i].consumed = false;
     }
+
+    BuildFoodGrid();
     
     g_target_radius = g_invader_start_radius * (float)g_difficulty;
     g_game_state = InGame;
@@ -243,11 +297,13 @@ void InitializeGameSpecifics()
     g_food_consumed = 0;
     g_background_color = ColorFromHSV(60.0f, 0.6f, 1.0f);
     g_attached_clumpnuggets = 0;
+    g_particles.count = 0;
 }
 
 void Update(const float frame_time)
 {
     UpdateMusicStream(g_ambient_music);
+    SampleInput();
     switch(g_game_state)
     {
         case GameInit:
@@ -257,7 +313,6 @@ void Update(const float frame_time)
         case InGame:
         {
             UpdateInGameState(frame_time);
-            UpdateCamera2D(frame_time);
             UpdateInvader(frame_time);
             UpdateClumpnuggets(frame_time);
             UpdateFood(frame_time);
@@ -281,17 +336,23 @@ void Update(const float frame_time)
             UpdateHowToPlay();
         }break;
     }
+
+    // the world is drawn in every state, so particles keep fading out between rounds
+    UpdateParticles(frame_time);
 }
 
-void UpdateCamera2D(const float frame_time)
+void SampleInput()
 {
-    g_camera.target = Vector2Add(g_camera.target, Vector2Scale(g_invader.velocity, frame_time));
+    // sampled once before simulating so this frame's thrust uses this frame's aim
+    g_input.mouse_position = GetMousePosition();
+    g_input.thrusters_on = IsKeyDown(KEY_SPACE);
+    g_input.sample_time = GetTime();
 }
 
 void UpdateInvader(const float frame_time)
 {
     const enum InvaderState last_state = g_invader.state;
-    g_invader.state = IsKeyDown(KEY_SPACE) ? Moving : Idle;
+    g_invader.state = g_input.thrusters_on ? Moving : Idle;
     const bool state_changed = last_state != g_invader.state;
 
     float speed_boost = 1.0f;
@@ -307,20 +368,20 @@ void UpdateInvader(const float frame_time)
         g_invader.dash_cooldown_timer = can_dash ? g_invader_dash_cooldown_timer_reset + g_attached_clumpnuggets * 0.3f : g_invader.dash_cooldown_timer;
     }
 
-    const float thrusters_on = g_invader.state == Moving ? 1.0f : 0.0f;
-    const float acceleration = max(100.0f, g_invader_acceleration - g_game_round * 50.0f);
-    g_invader.velocity = Vector2Add(g_invader.velocity, Vector2Scale(g_invader.look_at_direction, thrusters_on * acceleration * frame_time));
-    g_invader.velocity = Vector2Add(g_invader.velocity, Vector2Scale(g_invader.velocity, -g_friction * frame_time));
-    g_invader.velocity = Vector2Scale(g_invader.velocity, speed_boost);
-
     const Vector2 screen_center = g_camera.offset;
-    g_invader.look_at_direction = Vector2Normalize(Vector2Subtract(GetMousePosition(), screen_center));
+    g_invader.look_at_direction = Vector2Normalize(Vector2Subtract(g_input.mouse_position, screen_center));
 
     g_invader.rotation = g_invader.look_at_direction.x > 0
         ? RAD2DEG * acosf(-g_invader.look_at_direction.y)
         : 180.0f + RAD2DEG * acosf(g_invader.look_at_direction.y);
 
-    g_invader.position = g_camera.target;
+    const float thrusters_on = g_invader.state == Moving ? 1.0f : 0.0f;
+    const float acceleration = max(100.0f, g_invader_acceleration - g_game_round * 50.0f);
+    g_invader.velocity = Vector2Add(g_invader.velocity, Vector2Scale(g_invader.look_at_direction, thrusters_on * acceleration * frame_time));
+    g_invader.velocity = Vector2Add(g_invader.velocity, Vector2Scale(g_invader.velocity, -g_friction * frame_time));
+    g_invader.velocity = Vector2Scale(g_invader.velocity, speed_boost);
+
+    g_invader.position = Vector2Add(g_invader.position, Vector2Scale(g_invader.velocity, frame_time));
 
     // consume food and grow invader
     g_invader.radius = g_invader_start_radius;
@@ -371,6 +432,7 @@ void UpdateClumpnuggets(const float frame_time)
         if(g_clumpnuggets[i].attached)
         {
             g_attached_clumpnuggets++;
+            EmitParticles(g_clumpnuggets[i].position, 24, 250.0f, 0.6f, DARKBROWN);
             g_clumpnuggets[i].attach_position = Vector2Subtract(g_clumpnuggets[i].position, g_invader.position);
         }
 
@@ -395,42 +457,202 @@ void UpdateClumpnuggets(const float frame_time)
 
 void UpdateFood(const float frame_time)
 {
-    for(int i = 0; i < _countof(g_food); ++i)
+    // food can't be consumed if a clumpnugget is attached and in the way
+    const Vector2 invader_direction = Vector2Normalize(g_invader.velocity);
+    for(int j = 0; j < g_alive_clumpnuggets; ++j)
     {
-        if(g_food[i].consumed)
+        if(!g_clumpnuggets[j].attached)
         {
             continue;
         }
 
-        // food can't be consumed if a clumpnugget is attached and in the way
-        for(int j = 0; j < g_alive_clumpnuggets; ++j)
+        // re-bucketing is deferred until the scan is done so food can't be nudged twice
+        Food* nudged_food[_countof(g_food)];
+        int nudged_count = 0;
+        const Rectangle shell_bounds = GetCircleBounds(g_clumpnuggets[j].position, g_clump_nugget_radius + g_food_radius);
+        const FoodGridRange range = GetFoodGridRange(shell_bounds);
+        for(int y = range.min_y; y <= range.max_y; ++y)
         {
-            if(!g_clumpnuggets[j].attached)
+            for(int x = range.min_x; x <= range.max_x; ++x)
             {
-                continue;
+                for(Food* food = g_food_grid[y][x]; food; food = food->next_in_cell)
+                {
+                    if(CheckCollisionCircles(g_clumpnuggets[j].position, g_clump_nugget_radius, food->position, g_food_radius))
+                    {
+                        const Vector2 direction = Vector2Normalize(Vector2Subtract(food->position, g_clumpnuggets[j].position));
+                        const float amount = Vector2DotProduct(direction, invader_direction);
+                        food->position = Vector2Add(food->position, Vector2Scale(direction, amount));
+                        nudged_food[nudged_count++] = food;
+                    }
+                }
             }
+        }
 
-            if(CheckCollisionCircles(g_clumpnuggets[j].position, g_clump_nugget_radius, g_food[i].position, g_food_radius))
+        for(int i = 0; i < nudged_count; ++i)
+        {
+            RefreshFoodGridCell(nudged_food[i]);
+        }
+    }
+
+    const float invader_radius = g_invader.radius - g_embed_distance;
+    const FoodGridRange range = GetFoodGridRange(GetCircleBounds(g_invader.position, invader_radius + g_food_radius));
+    for(int y = range.min_y; y <= range.max_y; ++y)
+    {
+        for(int x = range.min_x; x <= range.max_x; ++x)
+        {
+            Food* food = g_food_grid[y][x];
+            while(food)
             {
-                const Vector2 direction = Vector2Normalize(Vector2Subtract(g_food[i].position, g_clumpnuggets[j].position));
-                const float amount = Vector2DotProduct(direction, Vector2Normalize(g_invader.velocity));
-                g_food[i].position = Vector2Add(g_food[i].position, Vector2Scale(direction, amount));
+                Food* next = food->next_in_cell;
+                food->consumed = CheckCollisionCircles(g_invader.position, invader_radius, food->position, g_food_radius);
+
+                if(food->consumed)
+                {
+                    RemoveFoodFromGrid(food);
+                    g_food_consumed++;
+                    g_hunger_timer = min(g_hunger_timer_reset, g_hunger_timer + 5);
+                    SetSoundVolume(g_pickup_sound, Lerp(0.01f, 0.1f, (float)GetRandomValue(0, 100) / 100.0f));
+                    SetSoundPitch(g_pickup_sound, Lerp(0.5f, 1.0f, (float)GetRandomValue(0, 100) / 100.0f));
+                    PlaySound(g_pickup_sound);
+                    EmitParticles(food->position, 8, 150.0f, 0.4f, RED);
+                }
+
+                food = next;
             }
         }
+    }
+}
 
-        g_food[i].consumed = CheckCollisionCircles(g_invader.position, g_invader.radius - g_embed_distance, g_food[i].position, g_food_radius);
-        
-        const int last_consumed = g_food_consumed;
-        g_food_consumed = g_food[i].consumed ? g_food_consumed + 1 : g_food_consumed;
-        const bool is_consumed = g_food_consumed > last_consumed;
-        g_hunger_timer = is_consumed ? min(g_hunger_timer_reset, g_hunger_timer + 5) : g_hunger_timer;
+void BuildFoodGrid()
+{
+    memset(g_food_grid, 0, sizeof(g_food_grid));
+    for(int i = 0; i < _countof(g_food); ++i)
+    {
+        if(!g_food[i].consumed)
+        {
+            InsertFoodIntoGrid(&g_food[i]);
+        }
+    }
+}
+
+void InsertFoodIntoGrid(Food* food)
+{
+    const FoodGridRange cell = GetFoodGridRange((Rectangle){food->position.x, food->position.y, 0.0f, 0.0f});
+    food->cell_x = cell.min_x;
+    food->cell_y = cell.min_y;
+    food->prev_in_cell = NULL;
+    food->next_in_cell = g_food_grid[food->cell_y][food->cell_x];
+
+    if(food->next_in_cell)
+    {
+        food->next_in_cell->prev_in_cell = food;
+    }
 
-        if(is_consumed)
+    g_food_grid[food->cell_y][food->cell_x] = food;
+}
+
+void RemoveFoodFromGrid(Food* food)
+{
+    if(food->prev_in_cell)
+    {
+        food->prev_in_cell->next_in_cell = food->next_in_cell;
+    }
+    else
+    {
+        g_food_grid[food->cell_y][food->cell_x] = food->next_in_cell;
+    }
+
+    if(food->next_in_cell)
+    {
+        food->next_in_cell->prev_in_cell = food->prev_in_cell;
+    }
+
+    food->prev_in_cell = NULL;
+    food->next_in_cell = NULL;
+}
+
+void RefreshFoodGridCell(Food* food)
+{
+    const FoodGridRange cell = GetFoodGridRange((Rectangle){food->position.x, food->position.y, 0.0f, 0.0f});
+    if(cell.min_x != food->cell_x || cell.min_y != food->cell_y)
+    {
+        RemoveFoodFromGrid(food);
+        InsertFoodIntoGrid(food);
+    }
+}
+
+FoodGridRange GetFoodGridRange(const Rectangle area)
+{
+    // non-finite areas (e.g. from a degenerate camera) map to an empty range
+    if(!isfinite(area.x) || !isfinite(area.y) || !isfinite(area.width) || !isfinite(area.height))
+    {
+        return (FoodGridRange){0, 0, -1, -1};
+    }
+
+    // anything outside the world bounds is clamped into the border cells
+    const int columns = _countof(g_food_grid[0]);
+    const int rows = _countof(g_food_grid);
+    const float cell_width = g_world_bounds.width / columns;
+    const float cell_height = g_world_bounds.height / rows;
+    return (FoodGridRange)
+    {
+        (int)Clamp(floorf((area.x - g_world_bounds.x) / cell_width), 0.0f, columns - 1.0f),
+        (int)Clamp(floorf((area.y - g_world_bounds.y) / cell_height), 0.0f, rows - 1.0f),
+        (int)Clamp(floorf((area.x + area.width - g_world_bounds.x) / cell_width), 0.0f, columns - 1.0f),
+        (int)Clamp(floorf((area.y + area.height - g_world_bounds.y) / cell_height), 0.0f, rows - 1.0f)
+    };
+}
+
+Rectangle GetCircleBounds(const Vector2 center, const float radius)
+{
+    return (Rectangle){center.x - radius, center.y - radius, radius * 2.0f, radius * 2.0f};
+}
+
+void EmitParticles(const Vector2 position, const int count, const float speed, const float lifetime, const Color color)
+{
+    // once the pool is full new particles are dropped, keeping the per-frame cost flat
+    const int capacity = _countof(g_particles.life);
+    const int emitted = min(count, capacity - g_particles.count);
+    for(int i = g_particles.count; i < g_particles.count + emitted; ++i)
+    {
+        const float angle = (float)GetRandomValue(0, 360) * DEG2RAD;
+        const float magnitude = speed * (float)GetRandomValue(50, 100) / 100.0f;
+        g_particles.position[i] = position;
+        g_particles.velocity[i] = (Vector2){cosf(angle) * magnitude, sinf(angle) * magnitude};
+        g_particles.life[i] = lifetime;
+        g_particles.lifetime[i] = lifetime;
+        g_particles.color[i] = color;
+    }
+
+    g_particles.count += emitted;
+}
+
+void UpdateParticles(const float frame_time)
+{
+    const float drag = max(0.0f, 1.0f - g_particle_drag * frame_time);
+    for(int i = 0; i < g_particles.count; ++i)
+    {
+        g_particles.life[i] -= frame_time;
+        g_particles.position[i].x += g_particles.velocity[i].x * frame_time;
+        g_particles.position[i].y += g_particles.velocity[i].y * frame_time;
+        g_particles.velocity[i].x *= drag;
+        g_particles.velocity[i].y *= drag;
+    }
+
+    for(int i = 0; i < g_particles.count;)
+    {
+        if(g_particles.life[i] > 0.0f)
         {
-            SetSoundVolume(g_pickup_sound, Lerp(0.01f, 0.1f, (float)GetRandomValue(0, 100) / 100.0f));
-            SetSoundPitch(g_pickup_sound, Lerp(0.5f, 1.0f, (float)GetRandomValue(0, 100) / 100.0f));
-            PlaySound(g_pickup_sound);
+            ++i;
+            continue;
         }
+
+        const int last = --g_particles.count;
+        g_particles.position[i] = g_particles.position[last];
+        g_particles.velocity[i] = g_particles.velocity[last];
+        g_particles.life[i] = g_particles.life[last];
+        g_particles.lifetime[i] = g_particles.lifetime[last];
+        g_particles.color[i] = g_particles.color[last];
     }
 }
 
@@ -500,6 +722,7 @@ void Render(const float frame_time)
     BeginDrawing();
     ClearBackground(ColorFromHSV(60.0f, 0.6f, 0.7f));
     BeginScissorMode(0, 0, g_screen_width, g_screen_height);
+    LateLatchView();
     BeginMode2D(g_camera);
     RenderWorld(frame_time);
     EndMode2D();
@@ -508,12 +731,19 @@ void Render(const float frame_time)
     EndDrawing();
 }
 
+void LateLatchView()
+{
+    // follow the invader position simulated this frame rather than last frame's
+    g_camera.target = g_invader.position;
+}
+
 void RenderWorld(const float frame_time)
 {
     RenderBackground();
     RenderClumpnuggets();
     RenderInvader();
     RenderFood();
+    RenderParticles();
 }
 
 void RenderBackground()
@@ -538,6 +768,48 @@ void RenderInvader()
     DrawCircleV(head_origin, 10.0f, color);
 }
 
+void RenderParticles()
+{
+    if(g_particles.count == 0)
+    {
+        return;
+    }
+
+    // every particle goes into a single quad batch instead of one draw call each
+    const Texture2D texture = GetShapesTexture();
+    const Rectangle source = GetShapesTextureRectangle();
+    const float u0 = source.x / texture.width;
+    const float v0 = source.y / texture.height;
+    const float u1 = (source.x + source.width) / texture.width;
+    const float v1 = (source.y + source.height) / texture.height;
+
+    rlCheckRenderBatchLimit(4 * g_particles.count);
+    rlSetTexture(texture.id);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+
+    for(int i = 0; i < g_particles.count; ++i)
+    {
+        const float t = g_particles.life[i] / g_particles.lifetime[i];
+        const float half_size = g_particle_size * t * 0.5f;
+        const float x = g_particles.position[i].x;
+        const float y = g_particles.position[i].y;
+        const Color color = Fade(g_particles.color[i], t);
+        rlColor4ub(color.r, color.g, color.b, color.a);
+        rlTexCoord2f(u0, v0);
+        rlVertex2f(x - half_size, y - half_size);
+        rlTexCoord2f(u0, v1);
+        rlVertex2f(x - half_size, y + half_size);
+        rlTexCoord2f(u1, v1);
+        rlVertex2f(x + half_size, y + half_size);
+        rlTexCoord2f(u1, v0);
+        rlVertex2f(x + half_size, y - half_size);
+    }
+
+    rlEnd();
+    rlSetTexture(0);
+}
+
 void RenderClumpnuggets()
 {
     const float rotation = 0.0f;
@@ -558,14 +830,20 @@ void RenderClumpnuggets()
 
 void RenderFood()
 {
-    for(int i = 0; i < _countof(g_food); ++i)
+    // consumed food is no longer bucketed, so only visible cells need walking
+    const Vector2 view_min = GetScreenToWorld2D(Vector2Zero(), g_camera);
+    const Vector2 view_max = GetScreenToWorld2D((Vector2){(float)g_screen_width, (float)g_screen_height}, g_camera);
+    const Rectangle view = {view_min.x - g_food_radius, view_min.y - g_food_radius, view_max.x - view_min.x + g_food_radius, view_max.y - view_min.y + g_food_radius};
+    const FoodGridRange range = GetFoodGridRange(view);
+    for(int y = range.min_y; y <= range.max_y; ++y)
     {
-        if(g_food[i].consumed)
+        for(int x = range.min_x; x <= range.max_x; ++x)
         {
-            continue;
+            for(const Food* food = g_food_grid[y][x]; food; food = food->next_in_cell)
+            {
+                DrawRectangleV(food->position, (Vector2){g_food_radius, g_food_radius}, RED);
+            }
         }
-
-        DrawRectangleV(g_food[i].position, (Vector2){g_food_radius, g_food_radius}, RED);
     }
 }
 
@@ -602,6 +880,7 @@ void RenderUI()
     if(g_debug_mode)
     {
         DrawFPS(10, 10);
+        DrawText(TextFormat("%.2f ms sample-to-swap", g_sample_to_swap_time * 1000.0f), 10, 32, 20, LIME);
     }
 }
 
@@ -638,7 +917,7 @@ void RenderInGameUI()
         DrawTextPro(g_font, TextFormat("Round %d", g_game_round), (Vector2){121.0f, 621.0f}, Vector2Zero(), 0.0f, 92.0f, 2.0f, Fade(BLACK, alpha));
     }
 
-    DrawCircleLinesV(GetMousePosition(), g_crosshair_radius, BLACK);
+    DrawCircleLinesV(g_input.mouse_position, g_crosshair_radius, BLACK);
 }
 
 void RenderGameWinUI()